@@ -0,0 +1,164 @@
+//
+// buffer_tee.h
+//
+
+#ifndef JETSON_MULTIMEDIA_API_DONE_RIGHT_BUFFER_TEE_H
+#define JETSON_MULTIMEDIA_API_DONE_RIGHT_BUFFER_TEE_H
+
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/* zero-copy fan-out of one buffer to several consumers
+ * a buffer pushed into the tee is shared (not copied) by every consumer, e.g. a recorder encoder,
+ * a preview converter and an analytics stage all reading the same camera frame.
+ * consumers get the frame read-only, writing to it would race with the other consumers.
+ *
+ * the buffer is handed back to its source through the release callback only after the last
+ * reference is dropped, so the source can re-queue it on its plane. the callback runs on whichever
+ * thread drops that reference: a consumer thread, or the producer inside Push() (no consumers,
+ * a dropped frame, or a Push() after Stop()). the source's re-queue path must be thread-safe.
+ *
+ * each consumer has its own bounded queue and policy:
+ *   kBlock      - Push() waits until the consumer has room, the consumer never misses a frame.
+ *   kDropOldest - the oldest pending frame is dropped (its reference released), Push() never waits.
+ * consumers must be added before the first Push().
+ *
+ * Stop() does not join anything: all producer and consumer threads must be joined before the tee
+ * is destroyed. frames still queued at destruction are released from the destructor.
+ * */
+template<typename BufferT>
+class BufferTee {
+public:
+    enum class Policy {
+        kBlock,
+        kDropOldest,
+    };
+
+    using FrameRef = std::shared_ptr<const BufferT>;
+    using ReleaseCallback = std::function<void(BufferT *)>;
+
+    explicit BufferTee(ReleaseCallback release) : release_(std::move(release)) {}
+
+    BufferTee(const BufferTee &) = delete;
+
+    BufferTee &operator=(const BufferTee &) = delete;
+
+    // returns the consumer id used by Pop(), depth must be at least 1
+    size_t AddConsumer(Policy policy, size_t depth) {
+        assert(!started_ && "consumers must be added before the first Push()");
+        if (depth == 0) {
+            throw std::invalid_argument("BufferTee consumer depth must be at least 1");
+        }
+        consumers_.push_back(std::make_unique<Consumer>(policy, depth));
+        return consumers_.size() - 1;
+    }
+
+    // fan the buffer out to every consumer, the tee takes the source's ownership of it.
+    // a null buffer is ignored, after Stop() the buffer is released right away.
+    void Push(BufferT *buffer) {
+        if (buffer == nullptr) {
+            return;
+        }
+        started_ = true;
+
+        ReleaseCallback release = release_;
+        FrameRef frame = std::shared_ptr<BufferT>(buffer, [release](BufferT *b) {
+            if (release) {
+                release(b);
+            }
+        });
+        if (stopped_) {
+            return;
+        }
+
+        for (auto &consumer: consumers_) {
+            FrameRef dropped;
+            {
+                std::unique_lock<std::mutex> lock(consumer->mutex);
+                if (consumer->policy == Policy::kBlock) {
+                    consumer->not_full.wait(lock, [&] {
+                        return stopped_ || consumer->queue.size() < consumer->depth;
+                    });
+                    if (stopped_) {
+                        continue;
+                    }
+                } else if (consumer->queue.size() >= consumer->depth) {
+                    // release outside the lock, the callback may re-queue to the device
+                    dropped = std::move(consumer->queue.front());
+                    consumer->queue.pop_front();
+                    ++consumer->num_dropped;
+                }
+                consumer->queue.push_back(frame);
+            }
+            consumer->not_empty.notify_one();
+        }
+    }
+
+    // wait for the next frame of a consumer, returns nullptr once the tee is stopped and drained
+    FrameRef Pop(size_t consumer_id) {
+        Consumer &consumer = *consumers_.at(consumer_id);
+        FrameRef frame;
+        {
+            std::unique_lock<std::mutex> lock(consumer.mutex);
+            consumer.not_empty.wait(lock, [&] {
+                return stopped_ || !consumer.queue.empty();
+            });
+            if (consumer.queue.empty()) {
+                return nullptr;
+            }
+            frame = std::move(consumer.queue.front());
+            consumer.queue.pop_front();
+        }
+        consumer.not_full.notify_one();
+        return frame;
+    }
+
+    size_t NumDropped(size_t consumer_id) const {
+        Consumer &consumer = *consumers_.at(consumer_id);
+        std::lock_guard<std::mutex> lock(consumer.mutex);
+        return consumer.num_dropped;
+    }
+
+    // wake up all blocked Push() / Pop(), pending frames can still be popped
+    void Stop() {
+        stopped_ = true;
+        for (auto &consumer: consumers_) {
+            {
+                // pairs with the predicate checks so no waiter misses the wake up
+                std::lock_guard<std::mutex> lock(consumer->mutex);
+            }
+            consumer->not_full.notify_all();
+            consumer->not_empty.notify_all();
+        }
+    }
+
+private:
+    struct Consumer {
+        Consumer(Policy p, size_t d) : policy(p), depth(d) {}
+
+        const Policy policy;
+        const size_t depth;
+        std::deque<FrameRef> queue;
+        size_t num_dropped{0};
+        mutable std::mutex mutex;
+        std::condition_variable not_full;
+        std::condition_variable not_empty;
+    };
+
+    ReleaseCallback release_;
+    std::vector<std::unique_ptr<Consumer>> consumers_;
+    std::atomic<bool> started_{false};
+    std::atomic<bool> stopped_{false};
+};
+
+
+#endif //JETSON_MULTIMEDIA_API_DONE_RIGHT_BUFFER_TEE_H
@@ -0,0 +1,126 @@
+//
+// buffer_tee_test.cpp
+//
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "buffer_tee.h"
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(1);                                                       \
+        }                                                                       \
+    } while (0)
+
+using Tee = BufferTee<int>;
+
+// the buffer goes back to the source only after the last consumer drops it
+static void TestReleaseAfterLastConsumer() {
+    std::vector<int *> released;
+    int buffer = 0;
+    Tee tee([&](int *b) { released.push_back(b); });
+    size_t a = tee.AddConsumer(Tee::Policy::kBlock, 2);
+    size_t b = tee.AddConsumer(Tee::Policy::kDropOldest, 2);
+
+    tee.Push(&buffer);
+    CHECK(released.empty());
+
+    Tee::FrameRef frame_a = tee.Pop(a);
+    Tee::FrameRef frame_b = tee.Pop(b);
+    CHECK(frame_a.get() == &buffer);
+    CHECK(frame_b.get() == &buffer);
+
+    frame_a.reset();
+    CHECK(released.empty());
+    frame_b.reset();
+    CHECK(released.size() == 1 && released[0] == &buffer);
+}
+
+// a full kDropOldest queue drops its oldest frame and returns it to the source at once
+static void TestDropOldest() {
+    std::vector<int *> released;
+    int buffers[3] = {0, 1, 2};
+    Tee tee([&](int *b) { released.push_back(b); });
+    size_t c = tee.AddConsumer(Tee::Policy::kDropOldest, 1);
+
+    tee.Push(&buffers[0]);
+    tee.Push(&buffers[1]);
+    CHECK(tee.NumDropped(c) == 1);
+    CHECK(released.size() == 1 && released[0] == &buffers[0]);
+
+    tee.Push(&buffers[2]);
+    CHECK(tee.NumDropped(c) == 2);
+    CHECK(released.size() == 2 && released[1] == &buffers[1]);
+
+    CHECK(tee.Pop(c).get() == &buffers[2]);
+    CHECK(released.size() == 3);
+}
+
+// a full kBlock queue holds Push() until the consumer pops
+static void TestBlockBackPressure() {
+    std::atomic<int> released{0};
+    int buffers[2] = {0, 1};
+    Tee tee([&](int *) { ++released; });
+    size_t c = tee.AddConsumer(Tee::Policy::kBlock, 1);
+
+    tee.Push(&buffers[0]);
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        tee.Push(&buffers[1]);
+        pushed = true;
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(!pushed);
+
+    CHECK(tee.Pop(c).get() == &buffers[0]);
+    producer.join();
+    CHECK(pushed);
+    CHECK(tee.Pop(c).get() == &buffers[1]);
+    CHECK(released == 2);
+}
+
+// Stop() keeps pending frames poppable, then Pop() returns nullptr
+static void TestStopDrains() {
+    std::atomic<int> released{0};
+    int buffers[3] = {0, 1, 2};
+    Tee tee([&](int *) { ++released; });
+    size_t c = tee.AddConsumer(Tee::Policy::kDropOldest, 4);
+
+    tee.Push(&buffers[0]);
+    tee.Push(&buffers[1]);
+    tee.Stop();
+
+    // pushed after Stop, goes straight back to the source
+    tee.Push(&buffers[2]);
+    CHECK(released == 1);
+
+    CHECK(tee.Pop(c).get() == &buffers[0]);
+    CHECK(tee.Pop(c).get() == &buffers[1]);
+    CHECK(tee.Pop(c) == nullptr);
+    CHECK(released == 3);
+
+    // a consumer blocked in Pop() is woken by Stop()
+    Tee idle([](int *) {});
+    size_t i = idle.AddConsumer(Tee::Policy::kBlock, 1);
+    std::thread consumer([&] { CHECK(idle.Pop(i) == nullptr); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    idle.Stop();
+    consumer.join();
+}
+
+int main() {
+    TestReleaseAfterLastConsumer();
+    TestDropOldest();
+    TestBlockBackPressure();
+    TestStopDrains();
+    std::printf("buffer_tee_test passed\n");
+    return 0;
+}